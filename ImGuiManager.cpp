@@ -2,6 +2,8 @@
 
 #include "CKRenderContext.h"
 
+#include <string.h>
+
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -10,23 +12,178 @@
 #include "imgui_impl_ck2.h"
 #include "backends/imgui_impl_win32.h"
 
+#include "InputEventQueue.h"
+
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 typedef LRESULT (CALLBACK *LPFNWNDPROC)(HWND, UINT, WPARAM, LPARAM);
 
+enum InputProducer {
+    INPUT_PRODUCER_MAIN = 0,
+    INPUT_PRODUCER_RENDER,
+    INPUT_PRODUCER_COUNT
+};
+
 static LPFNWNDPROC g_MainWndProc = nullptr;
 static LPFNWNDPROC g_RenderWndProc = nullptr;
+static InputEventQueue<INPUT_PRODUCER_COUNT, 256> g_InputQueue;
+static uint32_t g_InputDroppedCount = 0;
+static bool g_InputFocusLost = false;
+
+// Keys the Win32 backend reads through GetKeyState() while handling a key message.
+static const int s_ModifierKeys[] = {
+    VK_SHIFT, VK_LSHIFT, VK_RSHIFT,
+    VK_CONTROL, VK_LCONTROL, VK_RCONTROL,
+    VK_MENU, VK_LMENU, VK_RMENU,
+    VK_LWIN, VK_RWIN,
+};
+
+static bool IsKeyMessage(UINT msg) {
+    return msg == WM_KEYDOWN || msg == WM_KEYUP || msg == WM_SYSKEYDOWN || msg == WM_SYSKEYUP;
+}
+
+static uint32_t CaptureKeyState() {
+    uint32_t state = 0;
+    for (int i = 0; i < (int) (sizeof(s_ModifierKeys) / sizeof(s_ModifierKeys[0])); ++i)
+        if (GetKeyState(s_ModifierKeys[i]) & 0x8000)
+            state |= 1u << i;
+    return state;
+}
+
+static bool ClassifyInputMessage(UINT msg, InputEventType &type) {
+    switch (msg) {
+        case WM_MOUSEMOVE:
+        case WM_NCMOUSEMOVE:
+            type = INPUT_EVENT_MOUSEMOVE;
+            return true;
+        case WM_MOUSEWHEEL:
+            type = INPUT_EVENT_MOUSEWHEEL;
+            return true;
+        case WM_MOUSEHWHEEL:
+            type = INPUT_EVENT_MOUSEHWHEEL;
+            return true;
+        case WM_MOUSELEAVE:
+        case WM_NCMOUSELEAVE:
+        case WM_LBUTTONDOWN: case WM_LBUTTONDBLCLK: case WM_LBUTTONUP:
+        case WM_RBUTTONDOWN: case WM_RBUTTONDBLCLK: case WM_RBUTTONUP:
+        case WM_MBUTTONDOWN: case WM_MBUTTONDBLCLK: case WM_MBUTTONUP:
+        case WM_XBUTTONDOWN: case WM_XBUTTONDBLCLK: case WM_XBUTTONUP:
+        case WM_KEYDOWN: case WM_KEYUP:
+        case WM_SYSKEYDOWN: case WM_SYSKEYUP:
+        case WM_CHAR:
+        case WM_SETFOCUS:
+        case WM_KILLFOCUS:
+        case WM_INPUTLANGCHANGE:
+        case WM_DEVICECHANGE:
+        case WM_DISPLAYCHANGE:
+            type = INPUT_EVENT_OTHER;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// The backend reads modifier keys and the mouse source from the thread state rather than the message,
+// so that state is put back to what it was when the message arrived for the duration of the replay.
+static void DispatchInputEvent(const InputEvent &event) {
+    WPARAM wParam = (WPARAM) event.WParam;
+    if (event.Type == INPUT_EVENT_MOUSEWHEEL || event.Type == INPUT_EVENT_MOUSEHWHEEL)
+        wParam = MAKEWPARAM(GET_KEYSTATE_WPARAM(wParam), (WORD) (SHORT) event.WheelDelta);
+
+    BYTE keys[256];
+    BYTE saved[256];
+    const bool restoreKeys = IsKeyMessage(event.Message) && GetKeyboardState(saved);
+    if (restoreKeys) {
+        memcpy(keys, saved, sizeof(keys));
+        for (int i = 0; i < (int) (sizeof(s_ModifierKeys) / sizeof(s_ModifierKeys[0])); ++i) {
+            BYTE &key = keys[s_ModifierKeys[i]];
+            key = (BYTE) ((key & 0x01) | ((event.KeyState & (1u << i)) ? 0x80 : 0x00));
+        }
+        SetKeyboardState(keys);
+    }
+    const LPARAM extraInfo = SetMessageExtraInfo((LPARAM) event.ExtraInfo);
+
+    ImGui_ImplWin32_WndProcHandler((HWND) event.Window, event.Message, wParam, (LPARAM) event.LParam);
+
+    SetMessageExtraInfo(extraInfo);
+    if (restoreKeys)
+        SetKeyboardState(saved);
+}
+
+// Input is queued and replayed once per frame in OnPreRender, so the game never waits on ImGui.
+// WM_SETCURSOR stays synchronous since its return value decides whether the game may set the cursor.
+static LRESULT HandleWndProc(LPFNWNDPROC wndProc, InputProducer producer, HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    InputEventType type;
+    if (msg == WM_SETCURSOR) {
+        if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
+            return 1;
+    } else if (ClassifyInputMessage(msg, type)) {
+        InputEvent event = {};
+        event.Type = type;
+        event.Window = hWnd;
+        event.Message = msg;
+        event.WParam = (uintptr_t) wParam;
+        event.LParam = (intptr_t) lParam;
+        event.ExtraInfo = (intptr_t) GetMessageExtraInfo();
+        if (IsKeyMessage(msg))
+            event.KeyState = CaptureKeyState();
+        if (type == INPUT_EVENT_MOUSEWHEEL || type == INPUT_EVENT_MOUSEHWHEEL)
+            event.WheelDelta = GET_WHEEL_DELTA_WPARAM(wParam);
+        g_InputQueue.Push(producer, event);
+    }
+    return wndProc(hWnd, msg, wParam, lParam);
+}
 
 static LRESULT MainWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-    if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
-        return 1;
-    return g_MainWndProc(hWnd, msg, wParam, lParam);
+    return HandleWndProc(g_MainWndProc, INPUT_PRODUCER_MAIN, hWnd, msg, wParam, lParam);
 }
 
 static LRESULT RenderWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-    if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
-        return 1;
-    return g_RenderWndProc(hWnd, msg, wParam, lParam);
+    return HandleWndProc(g_RenderWndProc, INPUT_PRODUCER_RENDER, hWnd, msg, wParam, lParam);
+}
+
+// A full ring drops whatever arrives next, which may be the release of a key or button ImGui saw going down.
+// ImGui only clears its key and mouse state when the frame ends without focus, so the focus loss is sent
+// on the frame the drop is noticed and focus is given back at the start of the next one. The Win32 backend
+// also keeps its own button mask and the mouse capture taken on button-down; a synthetic button-up is
+// replayed for every button no longer held so that both are released as well.
+
+static void RestoreInputFocus(HWND hMainWnd, HWND hRenderWnd) {
+    if (!g_InputFocusLost)
+        return;
+    g_InputFocusLost = false;
+
+    HWND hForegroundWnd = GetForegroundWindow();
+    if (hForegroundWnd == hMainWnd || hForegroundWnd == hRenderWnd)
+        ImGui::GetIO().AddFocusEvent(true);
+}
+
+static void ReleaseMouseButtons(HWND hWnd) {
+    if (!(GetKeyState(VK_LBUTTON) & 0x8000))
+        ImGui_ImplWin32_WndProcHandler(hWnd, WM_LBUTTONUP, 0, 0);
+    if (!(GetKeyState(VK_RBUTTON) & 0x8000))
+        ImGui_ImplWin32_WndProcHandler(hWnd, WM_RBUTTONUP, 0, 0);
+    if (!(GetKeyState(VK_MBUTTON) & 0x8000))
+        ImGui_ImplWin32_WndProcHandler(hWnd, WM_MBUTTONUP, 0, 0);
+    if (!(GetKeyState(VK_XBUTTON1) & 0x8000))
+        ImGui_ImplWin32_WndProcHandler(hWnd, WM_XBUTTONUP, MAKEWPARAM(0, XBUTTON1), 0);
+    if (!(GetKeyState(VK_XBUTTON2) & 0x8000))
+        ImGui_ImplWin32_WndProcHandler(hWnd, WM_XBUTTONUP, MAKEWPARAM(0, XBUTTON2), 0);
+}
+
+static void RecoverDroppedInput(HWND hMainWnd, HWND hRenderWnd) {
+    const uint32_t dropped = g_InputQueue.GetDroppedCount();
+    if (dropped == g_InputDroppedCount)
+        return;
+    g_InputDroppedCount = dropped;
+
+    // The backend only releases its capture from the window holding it
+    ReleaseMouseButtons(hMainWnd);
+    if (hRenderWnd != hMainWnd)
+        ReleaseMouseButtons(hRenderWnd);
+
+    ImGui::GetIO().AddFocusEvent(false);
+    g_InputFocusLost = true;
 }
 
 static void HookWndProc(HWND hMainWnd, HWND hRenderWnd) {
@@ -76,6 +233,8 @@ CKERROR ImGuiManager::PreClearAll() {
         ImGui_ImplCK2_Shutdown();
 
         UnhookWndProc((HWND) m_Context->GetMainWindow(), (HWND) m_Context->GetPlayerRenderContext()->GetWindowHandle());
+        g_InputQueue.Clear();
+        g_InputFocusLost = false;
 
         m_Render = false;
         m_Initialized = false;
@@ -101,6 +260,9 @@ CKERROR ImGuiManager::OnCKPostReset() {
 CKERROR ImGuiManager::OnPreRender(CKRenderContext *dev) {
     if (m_Render) {
         ImGui_ImplCK2_NewFrame();
+        RestoreInputFocus((HWND) m_Context->GetMainWindow(), (HWND) dev->GetWindowHandle());
+        g_InputQueue.Drain(DispatchInputEvent);
+        RecoverDroppedInput((HWND) m_Context->GetMainWindow(), (HWND) dev->GetWindowHandle());
         ImGui_ImplWin32_NewFrame();
         ImGui::NewFrame();
     }
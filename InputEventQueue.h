@@ -0,0 +1,229 @@
+#ifndef INPUTEVENTQUEUE_H
+#define INPUTEVENTQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Platform-neutral input event queue sitting between the window hooks and ImGui.
+// Each producer owns a fixed-capacity single-producer/single-consumer ring; the
+// consumer drains every ring once per frame and replays the events in stamp order.
+// Neither side ever blocks: a full ring drops the event, and a slot the producer
+// is coalescing into is simply left for the next drain.
+
+enum InputEventType {
+    INPUT_EVENT_OTHER = 0,
+    INPUT_EVENT_MOUSEMOVE,
+    INPUT_EVENT_MOUSEWHEEL,
+    INPUT_EVENT_MOUSEHWHEEL,
+};
+
+struct InputEvent {
+    InputEventType Type;
+    void *Window;
+    unsigned int Message;
+    uintptr_t WParam;
+    intptr_t LParam;
+    int WheelDelta;         // Accumulated wheel delta, only meaningful for wheel events
+    uint32_t KeyState;      // Platform-defined modifier snapshot taken when the event was pushed
+    intptr_t ExtraInfo;     // Platform-defined message extra info taken when the event was pushed
+    uint32_t Sequence;      // Enqueue stamp, assigned by InputEventQueue::Push()
+};
+
+// Merge 'src' into 'dst' if both describe the same redundant input.
+// Mouse moves keep the latest payload, wheel deltas are accumulated while they fit in 16 bits.
+inline bool CoalesceInputEvent(InputEvent &dst, const InputEvent &src) {
+    if (dst.Type != src.Type || dst.Window != src.Window || dst.Message != src.Message)
+        return false;
+
+    switch (src.Type) {
+        case INPUT_EVENT_MOUSEMOVE:
+            dst.WParam = src.WParam;
+            dst.LParam = src.LParam;
+            dst.KeyState = src.KeyState;
+            dst.ExtraInfo = src.ExtraInfo;
+            break;
+        case INPUT_EVENT_MOUSEWHEEL:
+        case INPUT_EVENT_MOUSEHWHEEL: {
+            int delta = dst.WheelDelta + src.WheelDelta;
+            if (delta < -32768 || delta > 32767)
+                return false;
+            dst.WParam = src.WParam;
+            dst.LParam = src.LParam;
+            dst.KeyState = src.KeyState;
+            dst.ExtraInfo = src.ExtraInfo;
+            dst.WheelDelta = delta;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    dst.Sequence = src.Sequence;
+    return true;
+}
+
+template <unsigned int Capacity>
+class InputEventRing {
+public:
+    InputEventRing() : m_Head(0), m_Tail(0), m_Dropped(0) {
+        for (unsigned int i = 0; i < Capacity; ++i)
+            m_Slots[i].State.store(SLOT_EMPTY, std::memory_order_relaxed);
+    }
+
+    // Producer side. Returns false if the ring is full and the event was dropped.
+    bool Push(const InputEvent &event) {
+        const uint32_t head = m_Head.load(std::memory_order_relaxed);
+
+        // Try to fold the event into the last one that has not been consumed yet.
+        if (event.Type != INPUT_EVENT_OTHER && head != m_Tail.load(std::memory_order_acquire)) {
+            Slot &last = m_Slots[(head - 1) & (Capacity - 1)];
+            uint32_t expected = SLOT_READY;
+            if (last.State.compare_exchange_strong(expected, SLOT_WRITING, std::memory_order_acquire)) {
+                const bool merged = CoalesceInputEvent(last.Event, event);
+                last.State.store(SLOT_READY, std::memory_order_release);
+                if (merged)
+                    return true;
+            }
+        }
+
+        if (head - m_Tail.load(std::memory_order_acquire) >= Capacity) {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Slot &slot = m_Slots[head & (Capacity - 1)];
+        slot.Event = event;
+        slot.State.store(SLOT_READY, std::memory_order_release);
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty or its last slot is being coalesced into.
+    bool Pop(InputEvent &event) {
+        const uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail == m_Head.load(std::memory_order_acquire))
+            return false;
+
+        Slot &slot = m_Slots[tail & (Capacity - 1)];
+        uint32_t expected = SLOT_READY;
+        if (!slot.State.compare_exchange_strong(expected, SLOT_READING, std::memory_order_acquire))
+            return false;
+
+        event = slot.Event;
+        slot.State.store(SLOT_EMPTY, std::memory_order_release);
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+
+private:
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    enum SlotState {
+        SLOT_EMPTY = 0,
+        SLOT_READY,
+        SLOT_WRITING,
+        SLOT_READING,
+    };
+
+    struct Slot {
+        std::atomic<uint32_t> State;
+        InputEvent Event;
+    };
+
+    Slot m_Slots[Capacity];
+    std::atomic<uint32_t> m_Head;
+    std::atomic<uint32_t> m_Tail;
+    std::atomic<uint32_t> m_Dropped;
+};
+
+template <unsigned int Producers, unsigned int Capacity>
+class InputEventQueue {
+public:
+    InputEventQueue() : m_Sequence(0) {}
+
+    // Called from the thread owning 'producer'; each producer index must have a single writer.
+    bool Push(unsigned int producer, const InputEvent &event) {
+        InputEvent stamped = event;
+        stamped.Sequence = m_Sequence.fetch_add(1, std::memory_order_relaxed);
+        return m_Rings[producer].Push(stamped);
+    }
+
+    // Called from the consumer thread only. Replays every pending event in enqueue order and returns
+    // the number dispatched. Adjacent events the producer failed to merge, because the consumer held
+    // the last slot at the time, are merged here instead; events from different producers never merge.
+    template <typename Fn>
+    unsigned int Drain(Fn fn) {
+        unsigned int counts[Producers];
+        unsigned int cursors[Producers];
+        for (unsigned int p = 0; p < Producers; ++p) {
+            unsigned int n = 0;
+            while (n < Capacity && m_Rings[p].Pop(m_Scratch[p][n]))
+                ++n;
+            counts[p] = n;
+            cursors[p] = 0;
+        }
+
+        unsigned int dispatched = 0;
+        bool hasPending = false;
+        unsigned int pendingProducer = 0;
+        InputEvent pending = InputEvent();
+        for (;;) {
+            // Pick the oldest head among the producers; stamps are compared modulo 2^32.
+            unsigned int next = Producers;
+            for (unsigned int p = 0; p < Producers; ++p) {
+                if (cursors[p] == counts[p])
+                    continue;
+                if (next == Producers ||
+                    (int32_t)(m_Scratch[p][cursors[p]].Sequence - m_Scratch[next][cursors[next]].Sequence) < 0)
+                    next = p;
+            }
+            if (next == Producers)
+                break;
+
+            const InputEvent &event = m_Scratch[next][cursors[next]++];
+            if (hasPending && pendingProducer == next && CoalesceInputEvent(pending, event))
+                continue;
+            if (hasPending) {
+                fn(pending);
+                ++dispatched;
+            }
+            pending = event;
+            pendingProducer = next;
+            hasPending = true;
+        }
+
+        if (hasPending) {
+            fn(pending);
+            ++dispatched;
+        }
+
+        return dispatched;
+    }
+
+    // Called from the consumer thread only. Discards every pending event.
+    void Clear() {
+        InputEvent event;
+        for (unsigned int p = 0; p < Producers; ++p)
+            while (m_Rings[p].Pop(event))
+                continue;
+    }
+
+    uint32_t GetDroppedCount() const {
+        uint32_t dropped = 0;
+        for (unsigned int p = 0; p < Producers; ++p)
+            dropped += m_Rings[p].GetDroppedCount();
+        return dropped;
+    }
+
+private:
+    static_assert(Producers != 0, "At least one producer is required");
+
+    InputEventRing<Capacity> m_Rings[Producers];
+    InputEvent m_Scratch[Producers][Capacity];
+    std::atomic<uint32_t> m_Sequence;
+};
+
+#endif // INPUTEVENTQUEUE_H
@@ -0,0 +1,264 @@
+#include "InputEventQueue.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            return false;                                                       \
+        }                                                                       \
+    } while (0)
+
+enum {
+    MSG_MOUSEMOVE = 1,
+    MSG_MOUSEWHEEL,
+    MSG_BUTTON,
+};
+
+typedef InputEventQueue<2, 256> TestQueue;
+
+static InputEvent MakeEvent(InputEventType type, unsigned int msg, void *window, intptr_t lParam) {
+    InputEvent event = {};
+    event.Type = type;
+    event.Window = window;
+    event.Message = msg;
+    event.LParam = lParam;
+    return event;
+}
+
+static void *Window(int index) {
+    return (void *) (intptr_t) (index + 1);
+}
+
+static bool TestCoalesceMouseMove() {
+    static TestQueue queue;
+    for (int i = 0; i < 1000; ++i)
+        CHECK(queue.Push(0, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(0), i)));
+
+    std::vector<InputEvent> events;
+    CHECK(queue.Drain([&](const InputEvent &e) { events.push_back(e); }) == 1);
+    CHECK(events.size() == 1);
+    CHECK(events[0].LParam == 999);
+    CHECK(queue.GetDroppedCount() == 0);
+
+    // A move after a button must not be folded across it
+    queue.Push(0, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(0), 1));
+    queue.Push(0, MakeEvent(INPUT_EVENT_OTHER, MSG_BUTTON, Window(0), 2));
+    queue.Push(0, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(0), 3));
+    queue.Push(0, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(0), 4));
+    events.clear();
+    CHECK(queue.Drain([&](const InputEvent &e) { events.push_back(e); }) == 3);
+    CHECK(events[0].LParam == 1 && events[1].LParam == 2 && events[2].LParam == 4);
+    return true;
+}
+
+static bool TestCoalesceMouseWheel() {
+    static TestQueue queue;
+    for (int i = 0; i < 10; ++i) {
+        InputEvent event = MakeEvent(INPUT_EVENT_MOUSEWHEEL, MSG_MOUSEWHEEL, Window(0), i);
+        event.WheelDelta = -120;
+        CHECK(queue.Push(0, event));
+    }
+
+    std::vector<InputEvent> events;
+    CHECK(queue.Drain([&](const InputEvent &e) { events.push_back(e); }) == 1);
+    CHECK(events[0].WheelDelta == -1200);
+    CHECK(events[0].LParam == 9);
+
+    // Vertical and horizontal wheels stay apart
+    InputEvent v = MakeEvent(INPUT_EVENT_MOUSEWHEEL, MSG_MOUSEWHEEL, Window(0), 0);
+    InputEvent h = MakeEvent(INPUT_EVENT_MOUSEHWHEEL, MSG_MOUSEWHEEL, Window(0), 0);
+    v.WheelDelta = h.WheelDelta = 120;
+    queue.Push(0, v);
+    queue.Push(0, h);
+    CHECK(queue.Drain([](const InputEvent &) {}) == 2);
+    return true;
+}
+
+static bool TestCoalesceMouseWheelClamp() {
+    static TestQueue queue;
+    const int count = 300; // 300 * 120 overflows a 16-bit delta
+    for (int i = 0; i < count; ++i) {
+        InputEvent event = MakeEvent(INPUT_EVENT_MOUSEWHEEL, MSG_MOUSEWHEEL, Window(0), i);
+        event.WheelDelta = 120;
+        CHECK(queue.Push(0, event));
+    }
+
+    std::vector<InputEvent> events;
+    queue.Drain([&](const InputEvent &e) { events.push_back(e); });
+    CHECK(events.size() == 2);
+
+    int total = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+        CHECK(events[i].WheelDelta >= -32768 && events[i].WheelDelta <= 32767);
+        total += events[i].WheelDelta;
+    }
+    CHECK(total == count * 120);
+    return true;
+}
+
+static bool TestNoCoalesceAcrossProducers() {
+    static TestQueue queue;
+    for (int i = 0; i < 10; ++i) {
+        CHECK(queue.Push(0, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(i & 1), i)));
+        CHECK(queue.Push(1, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(2), i)));
+    }
+
+    std::vector<InputEvent> events;
+    queue.Drain([&](const InputEvent &e) { events.push_back(e); });
+    CHECK(events.size() == 11);
+    CHECK(events.back().Window == Window(2) && events.back().LParam == 9);
+
+    // Adjacent moves from two producers sharing a window are not merged by the drain
+    CHECK(queue.Push(0, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(0), 0)));
+    CHECK(queue.Push(1, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(0), 1)));
+    CHECK(queue.Drain([](const InputEvent &) {}) == 2);
+    return true;
+}
+
+static bool TestRingFullDrops() {
+    static TestQueue queue;
+    for (int i = 0; i < 256; ++i)
+        CHECK(queue.Push(0, MakeEvent(INPUT_EVENT_OTHER, MSG_BUTTON, Window(0), i)));
+    CHECK(!queue.Push(0, MakeEvent(INPUT_EVENT_OTHER, MSG_BUTTON, Window(0), 256)));
+    CHECK(queue.GetDroppedCount() == 1);
+
+    // Other producers are unaffected
+    CHECK(queue.Push(1, MakeEvent(INPUT_EVENT_OTHER, MSG_BUTTON, Window(1), 0)));
+
+    unsigned int n = queue.Drain([](const InputEvent &) {});
+    CHECK(n == 257);
+    CHECK(queue.Push(0, MakeEvent(INPUT_EVENT_OTHER, MSG_BUTTON, Window(0), 0)));
+    CHECK(queue.GetDroppedCount() == 1);
+
+    // A full ring still absorbs moves into its last slot
+    queue.Clear();
+    for (int i = 0; i < 255; ++i)
+        queue.Push(0, MakeEvent(INPUT_EVENT_OTHER, MSG_BUTTON, Window(0), i));
+    for (int i = 0; i < 100; ++i)
+        CHECK(queue.Push(0, MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(0), i)));
+    CHECK(queue.GetDroppedCount() == 1);
+    CHECK(queue.Drain([](const InputEvent &) {}) == 256);
+    return true;
+}
+
+static bool TestMultiProducerOrdering() {
+    static TestQueue queue;
+    const int count = 200000;
+    std::atomic<int> finished(0);
+
+    // Every fourth event is a button that must arrive exactly once and in order; the rest are moves.
+    auto produce = [&](int producer) {
+        for (int i = 0; i < count; ++i) {
+            InputEvent event = (i % 4 == 0)
+                               ? MakeEvent(INPUT_EVENT_OTHER, MSG_BUTTON, Window(producer), i)
+                               : MakeEvent(INPUT_EVENT_MOUSEMOVE, MSG_MOUSEMOVE, Window(producer), i);
+            while (!queue.Push(producer, event))
+                std::this_thread::yield();
+        }
+        finished.fetch_add(1);
+    };
+
+    std::thread a(produce, 0);
+    std::thread b(produce, 1);
+
+    intptr_t last[2] = {-1, -1};
+    int buttons[2] = {0, 0};
+    bool ok = true;
+    for (;;) {
+        const bool done = finished.load() == 2;
+        bool first = true;
+        uint32_t sequence = 0;
+        unsigned int n = queue.Drain([&](const InputEvent &e) {
+            const int p = (int) (intptr_t) e.Window - 1;
+            if (e.LParam <= last[p])
+                ok = false;
+            if (!first && (int32_t) (e.Sequence - sequence) < 0)
+                ok = false;
+            if (e.Type == INPUT_EVENT_OTHER) {
+                if (e.LParam % 4 != 0)
+                    ok = false;
+                ++buttons[p];
+            }
+            last[p] = e.LParam;
+            sequence = e.Sequence;
+            first = false;
+        });
+        if (done && n == 0)
+            break;
+        std::this_thread::yield();
+    }
+
+    a.join();
+    b.join();
+
+    CHECK(ok);
+    CHECK(buttons[0] == count / 4 && buttons[1] == count / 4);
+    CHECK(last[0] == count - 1 && last[1] == count - 1);
+    return true;
+}
+
+static bool TestThroughput() {
+    static TestQueue queue;
+    const int frames = 20000;
+    const int perFrame = 200;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned int dispatched = 0;
+    for (int f = 0; f < frames; ++f) {
+        for (int i = 0; i < perFrame; ++i) {
+            InputEventType type = (i % 50 == 0) ? INPUT_EVENT_OTHER : INPUT_EVENT_MOUSEMOVE;
+            CHECK(queue.Push(i & 1, MakeEvent(type, MSG_MOUSEMOVE, Window(i & 1), i)));
+        }
+        dispatched += queue.Drain([](const InputEvent &) {});
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double pushed = (double) frames * perFrame;
+    printf("%.0f events pushed, %u dispatched, %.1fM events/s\n", pushed, dispatched, pushed / seconds / 1e6);
+    CHECK(dispatched < pushed / 10);
+    CHECK(queue.GetDroppedCount() == 0);
+    return true;
+}
+
+struct TestCase {
+    const char *Name;
+    bool (*Run)();
+};
+
+static const TestCase s_TestCases[] = {
+    {"CoalesceMouseMove", TestCoalesceMouseMove},
+    {"CoalesceMouseWheel", TestCoalesceMouseWheel},
+    {"CoalesceMouseWheelClamp", TestCoalesceMouseWheelClamp},
+    {"NoCoalesceAcrossProducers", TestNoCoalesceAcrossProducers},
+    {"RingFullDrops", TestRingFullDrops},
+    {"MultiProducerOrdering", TestMultiProducerOrdering},
+    {"Throughput", TestThroughput},
+};
+
+int main(int argc, char *argv[]) {
+    int failed = 0;
+    int ran = 0;
+    for (size_t i = 0; i < sizeof(s_TestCases) / sizeof(s_TestCases[0]); ++i) {
+        if (argc > 1 && strcmp(argv[1], s_TestCases[i].Name) != 0)
+            continue;
+        ++ran;
+        if (!s_TestCases[i].Run()) {
+            fprintf(stderr, "%s failed\n", s_TestCases[i].Name);
+            ++failed;
+        }
+    }
+
+    if (ran == 0) {
+        fprintf(stderr, "Unknown test case: %s\n", argv[1]);
+        return 1;
+    }
+    return failed ? 1 : 0;
+}